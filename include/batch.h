@@ -0,0 +1,24 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+
+struct BatchOptions {
+    std::string script_path;
+    std::string storage_path = "./data/fs_storage";
+    size_t sessions = 1;     // Concurrent client threads
+    size_t iterations = 1;   // Times each session replays the script
+    double corrupt_rate = 0; // Probability of corrupting a block before each op
+    unsigned seed = 1;
+    bool format = false;     // Format the filesystem before starting
+};
+
+// Replay a command script or recorded trace across concurrent sessions
+// without prompts, then print throughput and latency percentiles per
+// command. Script lines use shell syntax; '#' starts a comment, "$SESSION"
+// expands to the session number and an optional "@<ms>" prefix schedules
+// the command relative to the start of the replay (as written by --record).
+// Returns the process exit code.
+int runBatch(const BatchOptions& options);
+
+#endif
@@ -3,13 +3,22 @@
 
 #include "storage.h"
 #include "recovery.h"
+#include "status.h"
 #include <map>
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <set>
 
 enum class NodeType { FILE, DIRECTORY };
 
+// Snapshots are exposed read-only under this top-level name
+constexpr const char* SNAPSHOT_DIR = ".snapshots";
+
+// INodes may be shared between the live tree, snapshots and clones.
+// A shared node (use_count > 1) is never modified in place: writers
+// copy the path down to it first (see findMutableNode).
 struct INode {
     std::string name;
     NodeType type;
@@ -25,29 +34,68 @@ private:
     RecoveryManager recovery;
     std::shared_ptr<INode> root;
     size_t next_block_id;
+    std::map<std::string, std::shared_ptr<INode>> snapshots;
+    std::map<size_t, size_t> block_refs; // Block id -> number of file INodes using it
+    mutable std::mutex mutex; // Serializes public operations across client threads
     
     std::shared_ptr<INode> findNode(const std::string& path);
+    std::shared_ptr<INode> findMutableNode(const std::string& path);
     std::vector<std::string> splitPath(const std::string& path);
+    bool isSnapshotPath(const std::vector<std::string>& parts) const;
     size_t allocateBlock();
     
+    std::shared_ptr<INode> cloneNode(const std::shared_ptr<INode>& node);
+    void releaseNode(std::shared_ptr<INode>& node);
+    void releaseBlock(size_t block_id);
+    void countRefs(const std::shared_ptr<INode>& node, std::set<const INode*>& seen,
+                   std::map<size_t, size_t>& refs) const;
+    
 public:
     FileSystem(const std::string& storage_path);
     
-    bool format();
-    bool mkdir(const std::string& path);
-    bool writeFile(const std::string& path, const std::string& data);
-    bool readFile(const std::string& path, std::string& data);
-    bool deleteFile(const std::string& path);
-    std::vector<std::string> ls(const std::string& path);
+    // No operation writes to the console; failures come back as a Status.
+    // All public operations are safe to call from multiple threads.
+    Status format();
+    Status mkdir(const std::string& path);
+    Status writeFile(const std::string& path, const std::string& data);
+    Status readFile(const std::string& path, std::string& data);
+    Status deleteFile(const std::string& path);
+    Status ls(const std::string& path, std::vector<std::string>& entries);
+    
+    // Copy-on-write: both are O(1) and share blocks until modified
+    Status snapshot(const std::string& path, const std::string& name);
+    Status clone(const std::string& src, const std::string& dst);
+    Status deleteSnapshot(const std::string& name);
+    std::vector<std::string> listSnapshots() const;
+    
+    // UNRECOVERABLE if any block has no valid replica left
+    Status fsck(RecoveryStats& stats);
     
-    bool fsck() {
-        recovery.checkAndRepairAll();
-        return true;
+    Status recover(size_t block_id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return recovery.checkAndRepairBlock(block_id) ? Status::OK : Status::UNRECOVERABLE;
     }
     
-    bool recover(size_t block_id) {
-        return recovery.checkAndRepairBlock(block_id);
+    // Foreground operations keep running between the copied blocks.
+    // IO_ERROR if no peer is available, UNRECOVERABLE if a block could not be copied
+    Status rebuildReplica(size_t replica, RebuildStats& stats, size_t max_bytes_per_sec = 0);
+    
+    // Fault injection for testing: silently damage one replica of a block
+    Status injectCorruption(size_t block_id, size_t replica);
+    std::vector<size_t> getLiveBlocks() const; // Blocks still referenced
+    
+    size_t getNumReplicas() const { return storage.getNumReplicas(); }
+    const std::string& getStoragePath() const { return storage.getBasePath(); }
+    
+    // Push buffered recovery log lines and index updates to disk
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex);
+        recovery.flushLog();
+        storage.flushTrees();
     }
+    
+    // Mirror recovery log lines to stdout (off by default)
+    void setRecoveryEcho(bool echo) { recovery.setEcho(echo); }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef MERKLE_H
+#define MERKLE_H
+
+#include "block.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Leaf hash of a block that is absent from a replica
+constexpr uint32_t EMPTY_LEAF = 0;
+
+// Hash of a block's data used as its leaf (never EMPTY_LEAF)
+uint32_t leafHash(const Block& block);
+
+// Binary hash tree over the per-block leaf hashes of one replica.
+// Leaves are indexed by block id; internal nodes hash their two children,
+// so two replicas agree on a range iff the covering nodes are equal.
+class MerkleTree {
+private:
+    size_t capacity;             // Number of leaves (power of two)
+    std::vector<uint32_t> nodes; // Heap layout: node i has children 2i and 2i+1
+
+    uint32_t combine(uint32_t left, uint32_t right) const;
+    void grow(size_t min_leaves);
+    void collectDiff(const MerkleTree& other, size_t node,
+                     std::vector<size_t>& leaves) const;
+
+public:
+    MerkleTree();
+
+    void setLeaf(size_t block_id, uint32_t hash);
+    uint32_t getLeaf(size_t block_id) const;
+
+    // Block id ranges [first, last] whose leaves differ between the trees
+    std::vector<std::pair<size_t, size_t>> diff(const MerkleTree& other) const;
+
+    // Leaves are persisted as a flat array of uint32 (internal nodes are rebuilt)
+    bool load(const std::string& path);
+    bool persistLeaf(std::ostream& file, size_t block_id) const;
+    bool save(const std::string& path) const;
+};
+
+#endif
@@ -4,28 +4,53 @@
 #include "storage.h"
 #include <string>
 #include <fstream>
+#include <mutex>
 
 struct RecoveryStats {
     size_t blocks_checked = 0;
     size_t corrupted_blocks = 0;
     size_t recovered_blocks = 0;
     size_t unrecoverable_blocks = 0;
+    size_t refs_repaired = 0;
+};
+
+struct RebuildStats {
+    size_t peers_used = 0; // Peers with a usable index
+    size_t divergent_ranges = 0;
+    size_t blocks_copied = 0;
+    size_t blocks_removed = 0;
+    size_t blocks_failed = 0;
+    size_t bytes_copied = 0;
+    double seconds = 0;
 };
 
 class RecoveryManager {
 private:
     BlockStorage& storage;
     std::ofstream log_file;
+    bool echo = false;
     
     void log(const std::string& message);
+    bool copyFromPeer(size_t block_id, size_t target, const std::vector<size_t>& peers,
+                      Block& buffer);
     
 public:
     RecoveryManager(BlockStorage& storage, const std::string& log_path);
     ~RecoveryManager();
     
+    void setEcho(bool enabled) { echo = enabled; }
+    void flushLog();
+    
     bool checkAndRepairBlock(size_t block_id);
     RecoveryStats checkAndRepairAll();
     bool verifyBlock(size_t block_id, size_t replica);
+    
+    // Anti-entropy rebuild of a lost or stale replica from its peers.
+    // max_bytes_per_sec throttles the copy (0 = unthrottled). io_lock guards
+    // storage against foreground operations; it is taken per copied block
+    // and never held while throttling, so the caller must not hold it.
+    RebuildStats rebuildReplica(size_t replica, size_t max_bytes_per_sec,
+                                std::mutex& io_lock);
 };
 
 #endif
\ No newline at end of file
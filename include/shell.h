@@ -0,0 +1,16 @@
+#ifndef SHELL_H
+#define SHELL_H
+
+#include "filesystem.h"
+#include <string>
+#include <vector>
+
+std::vector<std::string> parseCommand(const std::string& line);
+void printHelp();
+
+// Run one shell command against fs. With verbose set, results and errors
+// are printed as in the interactive shell; otherwise nothing is printed.
+// Unknown commands and bad arguments return Status::INVALID_ARGUMENT.
+Status runCommand(FileSystem& fs, const std::vector<std::string>& tokens, bool verbose);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef STATUS_H
+#define STATUS_H
+
+// Result of a filesystem operation. The library never prints; callers
+// turn a Status into text with statusMessage() if they want to.
+enum class Status {
+    OK,
+    NOT_FOUND,
+    ALREADY_EXISTS,
+    NOT_A_DIRECTORY,
+    NOT_A_FILE,
+    INVALID_ARGUMENT,
+    READ_ONLY,
+    IO_ERROR,
+    UNRECOVERABLE
+};
+
+const char* statusMessage(Status status);
+
+#endif
@@ -2,6 +2,8 @@
 #define STORAGE_H
 
 #include "block.h"
+#include "merkle.h"
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -12,9 +14,21 @@ class BlockStorage {
 private:
     std::string base_path;
     size_t num_replicas;
+    std::vector<MerkleTree> trees; // One hash tree per replica
+    std::vector<std::fstream> tree_files; // Open index of each replica, for leaf updates
+    std::vector<bool> tree_loaded;        // False while a replica has no usable index
     
     std::string getBlockPath(size_t replica, size_t block_id) const;
     std::string getReplicaPath(size_t replica) const;
+    std::string getTreePath(size_t replica) const;
+    std::fstream& openTreeFile(size_t replica);
+    
+    // With persist unset only the in-memory tree changes; call saveTree later
+    bool writeReplica(size_t replica, size_t block_id, const Block& block,
+                      bool persist = true);
+    void updateLeaf(size_t replica, size_t block_id, uint32_t hash, bool persist = true);
+    bool saveTree(size_t replica);
+    void scanTree(size_t replica);
     
 public:
     // Make RecoveryManager a friend so it can access private methods
@@ -26,9 +40,18 @@ public:
     bool writeBlock(size_t block_id, const Block& block);
     bool readBlock(size_t block_id, size_t replica, Block& block) const;
     bool blockExists(size_t block_id, size_t replica) const;
+    bool deleteBlock(size_t block_id);
+    bool corruptBlock(size_t block_id, size_t replica);
     
     size_t getNumReplicas() const { return num_replicas; }
+    const std::string& getBasePath() const { return base_path; }
     std::vector<size_t> getAllBlockIds() const;
+    std::vector<size_t> getBlockIds(size_t replica) const;
+    
+    const MerkleTree& getTree(size_t replica) const { return trees[replica]; }
+    bool reloadTree(size_t replica);
+    bool isTreeLoaded(size_t replica) const { return tree_loaded[replica]; }
+    void flushTrees();
 };
 
 #endif
\ No newline at end of file
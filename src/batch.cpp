@@ -0,0 +1,233 @@
+#include "../include/batch.h"
+#include "../include/shell.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <thread>
+
+struct TraceOp {
+    long at_ms = -1; // Scheduled offset, or -1 to run as soon as possible
+    std::string line;
+};
+
+struct CommandStats {
+    std::vector<double> latencies_us;
+    size_t errors = 0;
+};
+
+struct SessionResult {
+    std::map<std::string, CommandStats> commands;
+    size_t inject_attempts = 0;
+    size_t injected = 0;
+};
+
+// On failure, error holds the reason (with the line number for bad lines)
+static bool loadTrace(const std::string& path, std::vector<TraceOp>& ops,
+                      std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open script";
+        return false;
+    }
+    
+    std::string line;
+    size_t line_no = 0;
+    while (std::getline(file, line)) {
+        line_no++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue;
+        
+        TraceOp op;
+        op.line = line.substr(start);
+        if (op.line[0] == '@') {
+            size_t space = op.line.find(' ');
+            std::string offset = op.line.substr(1, space == std::string::npos
+                                                       ? std::string::npos : space - 1);
+            // Digits only: rejects negative offsets as well as junk
+            bool valid = !offset.empty() &&
+                         offset.find_first_not_of("0123456789") == std::string::npos;
+            if (valid) {
+                try {
+                    op.at_ms = std::stol(offset);
+                } catch (const std::exception&) {
+                    valid = false; // Out of range
+                }
+            }
+            if (!valid) {
+                error = "line " + std::to_string(line_no) + ": invalid @ offset '" + offset + "'";
+                return false;
+            }
+            if (space == std::string::npos) continue;
+            op.line = op.line.substr(space + 1);
+        }
+        ops.push_back(op);
+    }
+    
+    return true;
+}
+
+static std::string expandSession(std::string line, size_t session) {
+    const std::string var = "$SESSION";
+    for (size_t pos = line.find(var); pos != std::string::npos; pos = line.find(var, pos)) {
+        line.replace(pos, var.size(), std::to_string(session));
+    }
+    return line;
+}
+
+static void runSession(FileSystem& fs, const BatchOptions& options,
+                       const std::vector<TraceOp>& trace, size_t session,
+                       SessionResult& result) {
+    // Tokenize up front so parsing does not count towards latency
+    std::vector<std::vector<std::string>> commands;
+    for (const auto& op : trace) {
+        commands.push_back(parseCommand(expandSession(op.line, session)));
+    }
+    
+    std::mt19937 rng(options.seed + static_cast<unsigned>(session));
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    
+    for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+        auto base = std::chrono::steady_clock::now();
+        
+        for (size_t i = 0; i < trace.size(); i++) {
+            if (commands[i].empty()) continue;
+            
+            if (options.corrupt_rate > 0 && chance(rng) < options.corrupt_rate) {
+                // Another session may free the block before it is hit; that
+                // attempt is counted but not reported as injected
+                result.inject_attempts++;
+                std::vector<size_t> blocks = fs.getLiveBlocks();
+                if (!blocks.empty()) {
+                    size_t block_id = blocks[rng() % blocks.size()];
+                    size_t replica = rng() % fs.getNumReplicas();
+                    if (fs.injectCorruption(block_id, replica) == Status::OK) {
+                        result.injected++;
+                    }
+                }
+            }
+            
+            auto start = std::chrono::steady_clock::now();
+            if (trace[i].at_ms >= 0) {
+                // Measure scheduled ops from their intended start, so time spent
+                // queued behind the lock or a slow earlier op still counts
+                auto scheduled = base + std::chrono::milliseconds(trace[i].at_ms);
+                std::this_thread::sleep_until(scheduled);
+                start = scheduled;
+            }
+            
+            Status status;
+            try {
+                status = runCommand(fs, commands[i], false);
+            } catch (const std::exception&) {
+                status = Status::INVALID_ARGUMENT; // e.g. non-numeric block id
+            }
+            auto end = std::chrono::steady_clock::now();
+            
+            CommandStats& stats = result.commands[commands[i][0]];
+            stats.latencies_us.push_back(
+                std::chrono::duration<double, std::micro>(end - start).count());
+            if (status != Status::OK) {
+                stats.errors++;
+            }
+        }
+    }
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[rank == 0 ? 0 : rank - 1];
+}
+
+int runBatch(const BatchOptions& options) {
+    std::vector<TraceOp> trace;
+    std::string error;
+    if (!loadTrace(options.script_path, trace, error)) {
+        std::cerr << options.script_path << ": " << error << std::endl;
+        return 1;
+    }
+    
+    FileSystem fs(options.storage_path);
+    if (options.format && fs.format() != Status::OK) {
+        std::cerr << "format: " << statusMessage(Status::IO_ERROR) << std::endl;
+        return 1;
+    }
+    
+    std::vector<SessionResult> results(options.sessions);
+    std::vector<std::thread> sessions;
+    
+    auto start = std::chrono::steady_clock::now();
+    for (size_t s = 0; s < options.sessions; s++) {
+        sessions.emplace_back(runSession, std::ref(fs), std::cref(options),
+                              std::cref(trace), s, std::ref(results[s]));
+    }
+    for (auto& session : sessions) {
+        session.join();
+    }
+    fs.flush();
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    // Merge per-session results
+    std::map<std::string, CommandStats> totals;
+    size_t total_ops = 0;
+    size_t inject_attempts = 0;
+    size_t injected = 0;
+    for (const auto& result : results) {
+        inject_attempts += result.inject_attempts;
+        injected += result.injected;
+        for (const auto& entry : result.commands) {
+            CommandStats& stats = totals[entry.first];
+            stats.latencies_us.insert(stats.latencies_us.end(),
+                                      entry.second.latencies_us.begin(),
+                                      entry.second.latencies_us.end());
+            stats.errors += entry.second.errors;
+            total_ops += entry.second.latencies_us.size();
+        }
+    }
+    
+    std::cout << "Batch: " << options.script_path << " (" << options.sessions
+              << " sessions x " << options.iterations << " iterations)\n"
+              << "Total: " << total_ops << " ops in " << std::fixed << std::setprecision(3)
+              << seconds << "s (" << std::setprecision(0)
+              << (seconds > 0 ? total_ops / seconds : 0) << " ops/s)\n";
+    if (options.corrupt_rate > 0) {
+        // The effective rate can fall short of the requested one: an attempt
+        // fails when no block is live yet or its block was freed meanwhile
+        std::cout << "Corruption injected: " << injected << " block replica(s) in "
+                  << inject_attempts << " attempt(s), " << inject_attempts - injected
+                  << " failed; rate " << std::setprecision(4)
+                  << (total_ops > 0 ? static_cast<double>(injected) / total_ops : 0)
+                  << " (requested " << options.corrupt_rate << ")\n";
+    }
+    
+    std::cout << "\n" << std::left << std::setw(16) << "command"
+              << std::right << std::setw(9) << "ops" << std::setw(8) << "errors"
+              << std::setw(11) << "ops/s" << std::setw(11) << "p50(us)"
+              << std::setw(11) << "p95(us)" << std::setw(11) << "p99(us)"
+              << std::setw(11) << "max(us)" << "\n";
+    
+    for (auto& entry : totals) {
+        std::vector<double>& samples = entry.second.latencies_us;
+        std::sort(samples.begin(), samples.end());
+        
+        std::cout << std::left << std::setw(16) << entry.first << std::right
+                  << std::setw(9) << samples.size() << std::setw(8) << entry.second.errors
+                  << std::setprecision(0) << std::setw(11)
+                  << (seconds > 0 ? samples.size() / seconds : 0)
+                  << std::setprecision(1)
+                  << std::setw(11) << percentile(samples, 50)
+                  << std::setw(11) << percentile(samples, 95)
+                  << std::setw(11) << percentile(samples, 99)
+                  << std::setw(11) << samples.back() << "\n";
+    }
+    std::cout << std::flush;
+    
+    return 0;
+}
@@ -1,7 +1,7 @@
 #include "../include/filesystem.h"
+#include <algorithm>
 #include <sstream>
 #include <cstring>
-#include <iostream>
 
 FileSystem::FileSystem(const std::string& storage_path)
     : storage(storage_path, 3),
@@ -24,11 +24,51 @@ std::vector<std::string> FileSystem::splitPath(const std::string& path) {
     return parts;
 }
 
+bool FileSystem::isSnapshotPath(const std::vector<std::string>& parts) const {
+    return !parts.empty() && parts[0] == SNAPSHOT_DIR;
+}
+
 std::shared_ptr<INode> FileSystem::findNode(const std::string& path) {
     if (path == "/") return root;
     
     std::vector<std::string> parts = splitPath(path);
     std::shared_ptr<INode> current = root;
+    size_t first = 0;
+    
+    if (isSnapshotPath(parts)) {
+        if (parts.size() == 1) {
+            // Synthetic listing of all snapshots
+            auto dir = std::make_shared<INode>(SNAPSHOT_DIR, NodeType::DIRECTORY);
+            dir->children = snapshots;
+            return dir;
+        }
+        
+        auto it = snapshots.find(parts[1]);
+        if (it == snapshots.end()) return nullptr;
+        
+        current = it->second;
+        first = 2;
+    }
+    
+    for (size_t i = first; i < parts.size(); i++) {
+        if (current->type != NodeType::DIRECTORY) return nullptr;
+        
+        auto it = current->children.find(parts[i]);
+        if (it == current->children.end()) return nullptr;
+        
+        current = it->second;
+    }
+    
+    return current;
+}
+
+std::shared_ptr<INode> FileSystem::findMutableNode(const std::string& path) {
+    std::vector<std::string> parts = splitPath(path);
+    if (isSnapshotPath(parts)) return nullptr; // Snapshots are read-only
+    
+    // Copy every shared node on the way down so the caller may modify it
+    if (root.use_count() > 1) root = cloneNode(root);
+    std::shared_ptr<INode> current = root;
     
     for (const auto& part : parts) {
         if (current->type != NodeType::DIRECTORY) return nullptr;
@@ -36,83 +76,119 @@ std::shared_ptr<INode> FileSystem::findNode(const std::string& path) {
         auto it = current->children.find(part);
         if (it == current->children.end()) return nullptr;
         
+        if (it->second.use_count() > 1) {
+            it->second = cloneNode(it->second);
+        }
         current = it->second;
     }
     
     return current;
 }
 
+std::shared_ptr<INode> FileSystem::cloneNode(const std::shared_ptr<INode>& node) {
+    // Shallow copy: children stay shared, blocks gain one more owner
+    auto copy = std::make_shared<INode>(*node);
+    for (size_t block_id : copy->block_ids) {
+        block_refs[block_id]++;
+    }
+    return copy;
+}
+
+void FileSystem::releaseNode(std::shared_ptr<INode>& node) {
+    if (!node) return;
+    
+    // Only the last owner gives back blocks; shared nodes live on elsewhere
+    if (node.use_count() == 1) {
+        if (node->type == NodeType::FILE) {
+            for (size_t block_id : node->block_ids) {
+                releaseBlock(block_id);
+            }
+        } else {
+            for (auto& child : node->children) {
+                releaseNode(child.second);
+            }
+        }
+    }
+    
+    node.reset();
+}
+
+void FileSystem::releaseBlock(size_t block_id) {
+    auto it = block_refs.find(block_id);
+    if (it == block_refs.end()) return;
+    
+    if (--it->second == 0) {
+        block_refs.erase(it);
+        storage.deleteBlock(block_id);
+    }
+}
+
 size_t FileSystem::allocateBlock() {
     return next_block_id++;
 }
 
-bool FileSystem::format() {
+Status FileSystem::format() {
+    std::lock_guard<std::mutex> lock(mutex);
     if (!storage.initialize()) {
-        return false;
+        return Status::IO_ERROR;
     }
     
     root = std::make_shared<INode>("/", NodeType::DIRECTORY);
     next_block_id = 0;
+    snapshots.clear();
+    block_refs.clear();
     
-    std::cout << "Filesystem formatted successfully" << std::endl;
-    return true;
+    return Status::OK;
 }
 
-bool FileSystem::mkdir(const std::string& path) {
+Status FileSystem::mkdir(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
     std::vector<std::string> parts = splitPath(path);
-    if (parts.empty()) return false;
+    if (parts.empty()) return Status::INVALID_ARGUMENT;
     
     std::string parent_path = "/";
     for (size_t i = 0; i < parts.size() - 1; i++) {
         parent_path += parts[i] + "/";
     }
     
-    std::shared_ptr<INode> parent = findNode(parent_path);
-    if (!parent || parent->type != NodeType::DIRECTORY) {
-        std::cerr << "Parent directory not found" << std::endl;
-        return false;
+    if (isSnapshotPath(parts)) {
+        return Status::READ_ONLY;
     }
     
+    std::shared_ptr<INode> parent = findMutableNode(parent_path);
+    if (!parent) return Status::NOT_FOUND;
+    if (parent->type != NodeType::DIRECTORY) return Status::NOT_A_DIRECTORY;
+    
     std::string dir_name = parts.back();
     if (parent->children.find(dir_name) != parent->children.end()) {
-        std::cerr << "Directory already exists" << std::endl;
-        return false;
+        return Status::ALREADY_EXISTS;
     }
     
     parent->children[dir_name] = std::make_shared<INode>(dir_name, NodeType::DIRECTORY);
-    std::cout << "Directory created: " << path << std::endl;
-    return true;
+    return Status::OK;
 }
 
-bool FileSystem::writeFile(const std::string& path, const std::string& data) {
+Status FileSystem::writeFile(const std::string& path, const std::string& data) {
+    std::lock_guard<std::mutex> lock(mutex);
     std::vector<std::string> parts = splitPath(path);
-    if (parts.empty()) return false;
+    if (parts.empty()) return Status::INVALID_ARGUMENT;
     
     std::string parent_path = "/";
     for (size_t i = 0; i < parts.size() - 1; i++) {
         parent_path += parts[i] + "/";
     }
     
-    std::shared_ptr<INode> parent = findNode(parent_path);
-    if (!parent || parent->type != NodeType::DIRECTORY) {
-        std::cerr << "Parent directory not found" << std::endl;
-        return false;
+    if (isSnapshotPath(parts)) {
+        return Status::READ_ONLY;
     }
     
-    std::string file_name = parts.back();
-    std::shared_ptr<INode> file_node;
+    std::shared_ptr<INode> parent = findMutableNode(parent_path);
+    if (!parent) return Status::NOT_FOUND;
+    if (parent->type != NodeType::DIRECTORY) return Status::NOT_A_DIRECTORY;
     
-    // Create or overwrite file
-    auto it = parent->children.find(file_name);
-    if (it != parent->children.end() && it->second->type == NodeType::FILE) {
-        file_node = it->second;
-        file_node->block_ids.clear(); // Overwrite
-    } else {
-        file_node = std::make_shared<INode>(file_name, NodeType::FILE);
-        parent->children[file_name] = file_node;
-    }
-    
-    // Write data in blocks
+    // Write data in blocks before touching the old contents, so a failed
+    // write leaves the file as it was
+    std::vector<size_t> block_ids;
     size_t offset = 0;
     while (offset < data.size()) {
         Block block;
@@ -121,41 +197,65 @@ bool FileSystem::writeFile(const std::string& path, const std::string& data) {
         block.computeChecksum();
         
         size_t block_id = allocateBlock();
+        block_refs[block_id] = 1;
+        block_ids.push_back(block_id);
+        
         if (!storage.writeBlock(block_id, block)) {
-            std::cerr << "Failed to write block" << std::endl;
-            return false;
+            for (size_t written : block_ids) {
+                releaseBlock(written);
+            }
+            return Status::IO_ERROR;
         }
         
-        file_node->block_ids.push_back(block_id);
         offset += to_copy;
     }
     
-    std::cout << "File written: " << path << " (" << data.size() 
-              << " bytes, " << file_node->block_ids.size() << " blocks)" << std::endl;
-    return true;
+    std::string file_name = parts.back();
+    std::shared_ptr<INode> file_node;
+    
+    // Create or overwrite file
+    auto it = parent->children.find(file_name);
+    if (it != parent->children.end() && it->second->type == NodeType::FILE &&
+        it->second.use_count() == 1) {
+        file_node = it->second;
+        for (size_t block_id : file_node->block_ids) {
+            releaseBlock(block_id);
+        }
+    } else {
+        // A shared file keeps its blocks for the snapshot or clone using it
+        if (it != parent->children.end()) {
+            std::shared_ptr<INode> old = it->second;
+            parent->children.erase(it);
+            releaseNode(old);
+        }
+        file_node = std::make_shared<INode>(file_name, NodeType::FILE);
+        parent->children[file_name] = file_node;
+    }
+    
+    file_node->block_ids = block_ids; // Overwrite
+    
+    return Status::OK;
 }
 
-bool FileSystem::readFile(const std::string& path, std::string& data) {
+Status FileSystem::readFile(const std::string& path, std::string& data) {
+    std::lock_guard<std::mutex> lock(mutex);
     std::shared_ptr<INode> node = findNode(path);
-    if (!node || node->type != NodeType::FILE) {
-        std::cerr << "File not found" << std::endl;
-        return false;
-    }
+    if (!node) return Status::NOT_FOUND;
+    if (node->type != NodeType::FILE) return Status::NOT_A_FILE;
     
     data.clear();
+    data.reserve(node->block_ids.size() * DATA_SIZE);
     
     for (size_t block_id : node->block_ids) {
         Block block;
         if (!storage.readBlock(block_id, 0, block)) {
-            std::cerr << "Failed to read block " << block_id << std::endl;
-            return false;
+            return Status::IO_ERROR;
         }
         
         if (!block.verifyChecksum()) {
-            std::cerr << "Block " << block_id << " corrupted, attempting recovery..." << std::endl;
+            // Repairs are recorded in the recovery log
             if (!recovery.checkAndRepairBlock(block_id)) {
-                std::cerr << "Recovery failed" << std::endl;
-                return false;
+                return Status::UNRECOVERABLE;
             }
             // Re-read after recovery
             storage.readBlock(block_id, 0, block);
@@ -167,16 +267,16 @@ bool FileSystem::readFile(const std::string& path, std::string& data) {
     // Trim null bytes
     data.erase(std::find(data.begin(), data.end(), '\0'), data.end());
     
-    return true;
+    return Status::OK;
 }
 
-std::vector<std::string> FileSystem::ls(const std::string& path) {
-    std::vector<std::string> entries;
+Status FileSystem::ls(const std::string& path, std::vector<std::string>& entries) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
     
     std::shared_ptr<INode> node = findNode(path);
-    if (!node || node->type != NodeType::DIRECTORY) {
-        return entries;
-    }
+    if (!node) return Status::NOT_FOUND;
+    if (node->type != NodeType::DIRECTORY) return Status::NOT_A_DIRECTORY;
     
     for (const auto& child : node->children) {
         std::string entry = child.first;
@@ -186,24 +286,181 @@ std::vector<std::string> FileSystem::ls(const std::string& path) {
         entries.push_back(entry);
     }
     
-    return entries;
+    return Status::OK;
 }
 
-bool FileSystem::deleteFile(const std::string& path) {
+Status FileSystem::deleteFile(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
     std::vector<std::string> parts = splitPath(path);
-    if (parts.empty()) return false;
+    if (parts.empty()) return Status::INVALID_ARGUMENT;
     
     std::string parent_path = "/";
     for (size_t i = 0; i < parts.size() - 1; i++) {
         parent_path += parts[i] + "/";
     }
     
-    std::shared_ptr<INode> parent = findNode(parent_path);
-    if (!parent) return false;
+    if (isSnapshotPath(parts)) {
+        return Status::READ_ONLY;
+    }
+    
+    std::shared_ptr<INode> parent = findMutableNode(parent_path);
+    if (!parent) return Status::NOT_FOUND;
+    if (parent->type != NodeType::DIRECTORY) return Status::NOT_A_DIRECTORY;
     
     std::string name = parts.back();
-    parent->children.erase(name);
+    auto it = parent->children.find(name);
+    if (it == parent->children.end()) return Status::NOT_FOUND;
+    
+    std::shared_ptr<INode> node = it->second;
+    parent->children.erase(it);
+    releaseNode(node);
+    
+    return Status::OK;
+}
+
+Status FileSystem::snapshot(const std::string& path, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (name.empty() || name.find('/') != std::string::npos) {
+        return Status::INVALID_ARGUMENT;
+    }
+    
+    if (snapshots.find(name) != snapshots.end()) {
+        return Status::ALREADY_EXISTS;
+    }
+    
+    std::vector<std::string> parts = splitPath(path);
+    std::shared_ptr<INode> node = findNode(path);
+    if (!node) return Status::NOT_FOUND;
+    if (isSnapshotPath(parts) && parts.size() == 1) return Status::INVALID_ARGUMENT;
+    
+    snapshots[name] = node;
+    return Status::OK;
+}
+
+Status FileSystem::clone(const std::string& src, const std::string& dst) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> src_parts = splitPath(src);
+    std::vector<std::string> dst_parts = splitPath(dst);
+    if (dst_parts.empty()) return Status::INVALID_ARGUMENT;
+    
+    if (isSnapshotPath(dst_parts)) {
+        return Status::READ_ONLY;
+    }
+    
+    if (src_parts.size() <= dst_parts.size() &&
+        std::equal(src_parts.begin(), src_parts.end(), dst_parts.begin())) {
+        return Status::INVALID_ARGUMENT; // Cloning a directory into itself
+    }
+    
+    std::shared_ptr<INode> node = findNode(src);
+    if (!node) return Status::NOT_FOUND;
+    if (isSnapshotPath(src_parts) && src_parts.size() == 1) return Status::INVALID_ARGUMENT;
+    
+    std::string parent_path = "/";
+    for (size_t i = 0; i < dst_parts.size() - 1; i++) {
+        parent_path += dst_parts[i] + "/";
+    }
+    
+    std::shared_ptr<INode> parent = findMutableNode(parent_path);
+    if (!parent) return Status::NOT_FOUND;
+    if (parent->type != NodeType::DIRECTORY) return Status::NOT_A_DIRECTORY;
+    
+    std::string name = dst_parts.back();
+    if (parent->children.find(name) != parent->children.end()) {
+        return Status::ALREADY_EXISTS;
+    }
     
-    std::cout << "Deleted: " << path << std::endl;
-    return true;
+    parent->children[name] = node;
+    return Status::OK;
+}
+
+Status FileSystem::deleteSnapshot(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = snapshots.find(name);
+    if (it == snapshots.end()) {
+        return Status::NOT_FOUND;
+    }
+    
+    std::shared_ptr<INode> node = it->second;
+    snapshots.erase(it);
+    releaseNode(node);
+    
+    return Status::OK;
+}
+
+std::vector<std::string> FileSystem::listSnapshots() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> names;
+    for (const auto& snap : snapshots) {
+        names.push_back(snap.first);
+    }
+    return names;
+}
+
+void FileSystem::countRefs(const std::shared_ptr<INode>& node, std::set<const INode*>& seen,
+                           std::map<size_t, size_t>& refs) const {
+    // Shared subtrees are counted once, like cloneNode/releaseNode do
+    if (!seen.insert(node.get()).second) return;
+    
+    if (node->type == NodeType::FILE) {
+        for (size_t block_id : node->block_ids) {
+            refs[block_id]++;
+        }
+    } else {
+        for (const auto& child : node->children) {
+            countRefs(child.second, seen, refs);
+        }
+    }
+}
+
+Status FileSystem::fsck(RecoveryStats& stats) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Recount block references across the live tree and all snapshots
+    std::set<const INode*> seen;
+    std::map<size_t, size_t> refs;
+    countRefs(root, seen, refs);
+    for (const auto& snap : snapshots) {
+        countRefs(snap.second, seen, refs);
+    }
+    
+    size_t fixed = 0;
+    for (const auto& entry : block_refs) {
+        if (refs.find(entry.first) == refs.end()) {
+            // Leaked block: nothing references it any more
+            storage.deleteBlock(entry.first);
+            fixed++;
+        } else if (refs[entry.first] != entry.second) {
+            fixed++;
+        }
+    }
+    block_refs = refs;
+    
+    stats = recovery.checkAndRepairAll();
+    stats.refs_repaired = fixed;
+    return stats.unrecoverable_blocks > 0 ? Status::UNRECOVERABLE : Status::OK;
+}
+
+Status FileSystem::rebuildReplica(size_t replica, RebuildStats& stats, size_t max_bytes_per_sec) {
+    if (replica >= storage.getNumReplicas()) return Status::INVALID_ARGUMENT;
+    
+    // Takes the lock itself, block by block
+    stats = recovery.rebuildReplica(replica, max_bytes_per_sec, mutex);
+    if (stats.peers_used == 0) return Status::IO_ERROR; // No peer to rebuild from
+    if (stats.blocks_failed > 0) return Status::UNRECOVERABLE;
+    return Status::OK;
+}
+
+Status FileSystem::injectCorruption(size_t block_id, size_t replica) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (replica >= storage.getNumReplicas()) return Status::INVALID_ARGUMENT;
+    return storage.corruptBlock(block_id, replica) ? Status::OK : Status::NOT_FOUND;
+}
+
+std::vector<size_t> FileSystem::getLiveBlocks() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<size_t> blocks;
+    for (const auto& entry : block_refs) {
+        blocks.push_back(entry.first);
+    }
+    return blocks;
 }
\ No newline at end of file
@@ -1,109 +1,119 @@
 #include "../include/filesystem.h"
+#include "../include/shell.h"
+#include "../include/batch.h"
+#include <chrono>
+#include <fstream>
 #include <iostream>
-#include <sstream>
-#include <vector>
-
-std::vector<std::string> parseCommand(const std::string& line) {
-    std::vector<std::string> tokens;
-    std::stringstream ss(line);
-    std::string token;
-    
-    while (ss >> token) {
-        tokens.push_back(token);
-    }
-    
-    return tokens;
-}
+#include <string>
 
-void printHelp() {
-    std::cout << "\nAvailable commands:\n"
-              << "  format                  - Initialize filesystem\n"
-              << "  mkdir <path>            - Create directory\n"
-              << "  ls <path>               - List directory contents\n"
-              << "  write <path> <data...>  - Write file\n"
-              << "  read <path>             - Read file\n"
-              << "  rm <path>               - Delete file/directory\n"
-              << "  fsck                    - Check and repair all blocks\n"
-              << "  recover <block_id>      - Recover specific block\n"
-              << "  help                    - Show this help\n"
-              << "  exit                    - Exit shell\n" << std::endl;
+void printUsage() {
+    std::cout << "Usage:\n"
+              << "  shfs --help                 - Show this help\n"
+              << "  shfs [--record <trace>]     - Interactive shell, optionally\n"
+              << "                                recording commands as a trace\n"
+              << "  shfs --batch <script> [options]\n"
+              << "      --sessions <n>          - Concurrent client sessions (default 1)\n"
+              << "      --iterations <n>        - Replays per session (default 1)\n"
+              << "      --corrupt-rate <p>      - Corrupt a block before each op\n"
+              << "                                with probability p\n"
+              << "      --seed <n>              - Random seed for corruption\n"
+              << "      --storage <path>        - Storage directory\n"
+              << "      --format                - Format before replaying\n" << std::endl;
 }
 
-int main() {
+int runShell(const std::string& record_path) {
     std::cout << "=================================\n"
               << "  Self-Healing File System v1.0\n"
               << "=================================\n" << std::endl;
-    
+
     FileSystem fs("./data/fs_storage");
-    
+    fs.setRecoveryEcho(true);
+
+    std::ofstream record;
+    if (!record_path.empty()) {
+        record.open(record_path, std::ios::app);
+    }
+    auto session_start = std::chrono::steady_clock::now();
+
     std::cout << "Type 'help' for commands, 'exit' to quit\n" << std::endl;
-    
+
     std::string line;
     while (true) {
         std::cout << "shfs> ";
-        std::getline(std::cin, line);
-        
+        if (!std::getline(std::cin, line)) break;
+
         if (line.empty()) continue;
-        
+
         std::vector<std::string> tokens = parseCommand(line);
         if (tokens.empty()) continue;
-        
+
         std::string cmd = tokens[0];
-        
+
         if (cmd == "exit" || cmd == "quit") {
             std::cout << "Goodbye!" << std::endl;
             break;
         }
         else if (cmd == "help") {
             printHelp();
+            continue;
         }
-        else if (cmd == "format") {
-            fs.format();
-        }
-        else if (cmd == "mkdir" && tokens.size() >= 2) {
-            fs.mkdir(tokens[1]);
+
+        if (record.is_open()) {
+            // Timestamped so --batch can replay the original pacing
+            auto offset = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - session_start).count();
+            record << "@" << offset << " " << line << "\n";
         }
-        else if (cmd == "ls") {
-            std::string path = tokens.size() >= 2 ? tokens[1] : "/";
-            auto entries = fs.ls(path);
-            
-            if (entries.empty()) {
-                std::cout << "(empty)" << std::endl;
+
+        runCommand(fs, tokens, true);
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    BatchOptions options;
+    std::string record_path;
+    bool batch = false;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+
+            if (arg == "--help" || arg == "-h") {
+                printUsage();
+                return 0;
+            } else if (arg == "--batch" && has_value) {
+                batch = true;
+                options.script_path = argv[++i];
+            } else if (arg == "--record" && has_value) {
+                record_path = argv[++i];
+            } else if (arg == "--sessions" && has_value) {
+                options.sessions = std::stoul(argv[++i]);
+            } else if (arg == "--iterations" && has_value) {
+                options.iterations = std::stoul(argv[++i]);
+            } else if (arg == "--corrupt-rate" && has_value) {
+                options.corrupt_rate = std::stod(argv[++i]);
+            } else if (arg == "--seed" && has_value) {
+                options.seed = std::stoul(argv[++i]);
+            } else if (arg == "--storage" && has_value) {
+                options.storage_path = argv[++i];
+            } else if (arg == "--format") {
+                options.format = true;
             } else {
-                for (const auto& entry : entries) {
-                    std::cout << "  " << entry << std::endl;
-                }
-            }
-        }
-        else if (cmd == "write" && tokens.size() >= 3) {
-            std::string path = tokens[1];
-            std::string data;
-            for (size_t i = 2; i < tokens.size(); i++) {
-                data += tokens[i];
-                if (i < tokens.size() - 1) data += " ";
-            }
-            fs.writeFile(path, data);
-        }
-        else if (cmd == "read" && tokens.size() >= 2) {
-            std::string data;
-            if (fs.readFile(tokens[1], data)) {
-                std::cout << "Content: " << data << std::endl;
+                printUsage();
+                return 1;
             }
         }
-        else if (cmd == "rm" && tokens.size() >= 2) {
-            fs.deleteFile(tokens[1]);
-        }
-        else if (cmd == "fsck") {
-            fs.fsck();
-        }
-        else if (cmd == "recover" && tokens.size() >= 2) {
-            size_t block_id = std::stoul(tokens[1]);
-            fs.recover(block_id);
-        }
-        else {
-            std::cout << "Unknown command or invalid arguments. Type 'help' for usage." << std::endl;
-        }
+    } catch (const std::exception&) {
+        // Non-numeric or out-of-range option value
+        printUsage();
+        return 1;
     }
-    
-    return 0;
-}
\ No newline at end of file
+
+    if (batch) {
+        return runBatch(options);
+    }
+    return runShell(record_path);
+}
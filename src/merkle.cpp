@@ -0,0 +1,133 @@
+#include "../include/merkle.h"
+#include <fstream>
+
+uint32_t leafHash(const Block& block) {
+    // Written blocks always carry the CRC of their data, so reuse it as the
+    // content hash. (A CRC over data plus its own CRC is a constant residue.)
+    return block.checksum == EMPTY_LEAF ? 1 : block.checksum;
+}
+
+MerkleTree::MerkleTree() : capacity(1), nodes(2, EMPTY_LEAF) {}
+
+uint32_t MerkleTree::combine(uint32_t left, uint32_t right) const {
+    // Empty subtrees stay empty so trees of different capacity still line up
+    if (left == EMPTY_LEAF && right == EMPTY_LEAF) return EMPTY_LEAF;
+
+    uint32_t pair[2] = { left, right };
+    uint32_t hash = crc32(reinterpret_cast<const uint8_t*>(pair), sizeof(pair));
+    return hash == EMPTY_LEAF ? 1 : hash;
+}
+
+void MerkleTree::grow(size_t min_leaves) {
+    if (min_leaves <= capacity) return;
+
+    size_t new_capacity = capacity;
+    while (new_capacity < min_leaves) new_capacity *= 2;
+
+    std::vector<uint32_t> new_nodes(2 * new_capacity, EMPTY_LEAF);
+    for (size_t i = 0; i < capacity; i++) {
+        new_nodes[new_capacity + i] = nodes[capacity + i];
+    }
+    for (size_t i = new_capacity - 1; i >= 1; i--) {
+        new_nodes[i] = combine(new_nodes[2 * i], new_nodes[2 * i + 1]);
+    }
+
+    capacity = new_capacity;
+    nodes.swap(new_nodes);
+}
+
+void MerkleTree::setLeaf(size_t block_id, uint32_t hash) {
+    grow(block_id + 1);
+
+    size_t i = capacity + block_id;
+    nodes[i] = hash;
+    for (i /= 2; i >= 1; i /= 2) {
+        nodes[i] = combine(nodes[2 * i], nodes[2 * i + 1]);
+    }
+}
+
+uint32_t MerkleTree::getLeaf(size_t block_id) const {
+    if (block_id >= capacity) return EMPTY_LEAF;
+    return nodes[capacity + block_id];
+}
+
+void MerkleTree::collectDiff(const MerkleTree& other, size_t node,
+                             std::vector<size_t>& leaves) const {
+    if (nodes[node] == other.nodes[node]) return;
+
+    if (node >= capacity) {
+        leaves.push_back(node - capacity);
+        return;
+    }
+
+    collectDiff(other, 2 * node, leaves);
+    collectDiff(other, 2 * node + 1, leaves);
+}
+
+std::vector<std::pair<size_t, size_t>> MerkleTree::diff(const MerkleTree& other) const {
+    if (capacity != other.capacity) {
+        MerkleTree a = *this;
+        MerkleTree b = other;
+        a.grow(b.capacity);
+        b.grow(a.capacity);
+        return a.diff(b);
+    }
+
+    std::vector<size_t> leaves;
+    collectDiff(other, 1, leaves);
+
+    // Coalesce adjacent leaves into ranges for sequential copying
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (size_t leaf : leaves) {
+        if (!ranges.empty() && ranges.back().second + 1 == leaf) {
+            ranges.back().second = leaf;
+        } else {
+            ranges.push_back({leaf, leaf});
+        }
+    }
+
+    return ranges;
+}
+
+bool MerkleTree::load(const std::string& path) {
+    *this = MerkleTree();
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    std::vector<uint32_t> leaves;
+    uint32_t hash;
+    while (file.read(reinterpret_cast<char*>(&hash), sizeof(hash))) {
+        leaves.push_back(hash);
+    }
+
+    grow(leaves.size());
+    for (size_t i = 0; i < leaves.size(); i++) {
+        nodes[capacity + i] = leaves[i];
+    }
+    for (size_t i = capacity - 1; i >= 1; i--) {
+        nodes[i] = combine(nodes[2 * i], nodes[2 * i + 1]);
+    }
+
+    return true;
+}
+
+bool MerkleTree::persistLeaf(std::ostream& file, size_t block_id) const {
+    uint32_t hash = getLeaf(block_id);
+    file.seekp(block_id * sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    return file.good();
+}
+
+bool MerkleTree::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&nodes[capacity]),
+               capacity * sizeof(uint32_t));
+    return file.good();
+}
@@ -2,6 +2,13 @@
 #include <iostream>
 #include <chrono>
 #include <iomanip>
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <thread>
+
+namespace fs = std::filesystem;
 
 RecoveryManager::RecoveryManager(BlockStorage& storage, const std::string& log_path)
     : storage(storage) {
@@ -24,10 +31,19 @@ void RecoveryManager::log(const std::string& message) {
     
     std::string log_msg = "[" + timestamp + "] " + message;
     
+    // Buffered: flushed at the end of fsck/rebuild, by flushLog() or on close
     if (log_file.is_open()) {
-        log_file << log_msg << std::endl;
+        log_file << log_msg << '\n';
+    }
+    if (echo) {
+        std::cout << log_msg << std::endl;
+    }
+}
+
+void RecoveryManager::flushLog() {
+    if (log_file.is_open()) {
+        log_file.flush();
     }
-    std::cout << log_msg << std::endl;
 }
 
 bool RecoveryManager::verifyBlock(size_t block_id, size_t replica) {
@@ -76,11 +92,7 @@ bool RecoveryManager::checkAndRepairBlock(size_t block_id) {
     
     // Overwrite corrupted replicas
     for (size_t replica : corrupted_replicas) {
-        std::string path = storage.getBlockPath(replica, block_id);
-        std::ofstream file(path, std::ios::binary);
-        if (file) {
-            file.write(reinterpret_cast<const char*>(&valid_block), sizeof(Block));
-            file.close();
+        if (storage.writeReplica(replica, block_id, valid_block)) {
             log("Block " + std::to_string(block_id) + ": Replica " + 
                 std::to_string(replica) + " RECOVERED from replica " + 
                 std::to_string(valid_replicas[0]));
@@ -117,10 +129,155 @@ RecoveryStats RecoveryManager::checkAndRepairAll() {
         }
     }
     
+    storage.flushTrees();
+    
     log("===== Check complete: " + std::to_string(stats.blocks_checked) + " blocks, " +
         std::to_string(stats.corrupted_blocks) + " corrupted, " +
         std::to_string(stats.recovered_blocks) + " recovered, " +
         std::to_string(stats.unrecoverable_blocks) + " unrecoverable =====");
+    flushLog();
+    
+    return stats;
+}
+
+bool RecoveryManager::copyFromPeer(size_t block_id, size_t target,
+                                   const std::vector<size_t>& peers, Block& buffer) {
+    // A stale peer's copy still passes its CRC, so prefer the version most
+    // peers agree on; ties fall back to the lower-numbered peer
+    std::map<uint32_t, size_t> votes;
+    std::vector<size_t> sources;
+    for (size_t replica : peers) {
+        uint32_t leaf = storage.getTree(replica).getLeaf(block_id);
+        if (leaf == EMPTY_LEAF) continue;
+        votes[leaf]++;
+        sources.push_back(replica);
+    }
+    
+    if (votes.size() > 1) {
+        log("Rebuild: peers disagree on block " + std::to_string(block_id) +
+            ", using the majority version");
+    }
+    
+    std::stable_sort(sources.begin(), sources.end(), [&](size_t a, size_t b) {
+        return votes[storage.getTree(a).getLeaf(block_id)] >
+               votes[storage.getTree(b).getLeaf(block_id)];
+    });
+    
+    for (size_t replica : sources) {
+        // The copy on disk must also be the version the peer's index claims
+        if (storage.readBlock(block_id, replica, buffer) && buffer.verifyChecksum() &&
+            leafHash(buffer) == storage.getTree(replica).getLeaf(block_id)) {
+            return storage.writeReplica(target, block_id, buffer, false);
+        }
+    }
+    return false;
+}
+
+RebuildStats RecoveryManager::rebuildReplica(size_t replica, size_t max_bytes_per_sec,
+                                             std::mutex& io_lock) {
+    RebuildStats stats;
+    std::unique_lock<std::mutex> lock(io_lock);
+    if (replica >= storage.getNumReplicas()) {
+        log("Rebuild: replica " + std::to_string(replica) + " does not exist");
+        return stats;
+    }
+    
+    log("===== Rebuilding replica " + std::to_string(replica) + " =====");
+    auto start = std::chrono::steady_clock::now();
+    
+    // Trust the on-disk index of the target, not what we last wrote to it
+    fs::create_directories(storage.getReplicaPath(replica));
+    storage.reloadTree(replica);
+    
+    // Only peers with a usable index can vouch for what a block should be
+    std::vector<size_t> peers;
+    for (size_t peer = 0; peer < storage.getNumReplicas(); peer++) {
+        if (peer == replica) continue;
+        if (storage.isTreeLoaded(peer) || storage.reloadTree(peer)) {
+            peers.push_back(peer);
+        } else {
+            log("Rebuild: replica " + std::to_string(peer) + " is missing, not used as a source");
+        }
+    }
+    stats.peers_used = peers.size();
+    bool all_peers = peers.size() == storage.getNumReplicas() - 1;
+    
+    // Union of ranges where the target disagrees with any peer
+    std::set<size_t> divergent;
+    for (size_t peer : peers) {
+        auto ranges = storage.getTree(replica).diff(storage.getTree(peer));
+        for (const auto& range : ranges) {
+            for (size_t id = range.first; id <= range.second; id++) {
+                divergent.insert(id);
+            }
+        }
+    }
+    
+    lock.unlock();
+    
+    size_t previous = 0;
+    for (size_t block_id : divergent) {
+        // Re-checked under the lock: foreground writes may have moved on
+        lock.lock();
+        
+        if (stats.divergent_ranges == 0 || block_id != previous + 1) {
+            stats.divergent_ranges++;
+        }
+        previous = block_id;
+        
+        bool wanted = false;
+        for (size_t peer : peers) {
+            if (storage.getTree(peer).getLeaf(block_id) != EMPTY_LEAF) {
+                wanted = true;
+            }
+        }
+        
+        if (!wanted && !all_peers) {
+            // A missing peer might still hold it: never delete on partial evidence
+            lock.unlock();
+            continue;
+        }
+        
+        if (!wanted) {
+            // Stale block that no peer holds any more
+            fs::remove(storage.getBlockPath(replica, block_id));
+            storage.updateLeaf(replica, block_id, EMPTY_LEAF, false);
+            stats.blocks_removed++;
+            lock.unlock();
+            continue;
+        }
+        
+        Block buffer;
+        if (!copyFromPeer(block_id, replica, peers, buffer)) {
+            log("Rebuild: block " + std::to_string(block_id) + " has no valid peer copy");
+            stats.blocks_failed++;
+            lock.unlock();
+            continue;
+        }
+        stats.blocks_copied++;
+        stats.bytes_copied += sizeof(Block);
+        lock.unlock();
+        
+        // Keep the copy rate at or below the budget left for foreground I/O
+        if (max_bytes_per_sec > 0) {
+            auto due = start + std::chrono::duration<double>(
+                static_cast<double>(stats.bytes_copied) / max_bytes_per_sec);
+            std::this_thread::sleep_until(due);
+        }
+    }
+    
+    // Leaves were only updated in memory; write the index out once
+    lock.lock();
+    storage.saveTree(replica);
+    
+    stats.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    log("===== Rebuild complete: " + std::to_string(stats.divergent_ranges) + " ranges, " +
+        std::to_string(stats.blocks_copied) + " copied, " +
+        std::to_string(stats.blocks_removed) + " removed, " +
+        std::to_string(stats.blocks_failed) + " failed =====");
+    flushLog();
     
     return stats;
 }
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "../include/shell.h"
+#include <iostream>
+#include <sstream>
+
+std::vector<std::string> parseCommand(const std::string& line) {
+    std::vector<std::string> tokens;
+    std::stringstream ss(line);
+    std::string token;
+    
+    while (ss >> token) {
+        tokens.push_back(token);
+    }
+    
+    return tokens;
+}
+
+void printHelp() {
+    std::cout << "\nAvailable commands:\n"
+              << "  format                  - Initialize filesystem\n"
+              << "  mkdir <path>            - Create directory\n"
+              << "  ls <path>               - List directory contents\n"
+              << "  write <path> <data...>  - Write file\n"
+              << "  read <path>             - Read file\n"
+              << "  rm <path>               - Delete file/directory\n"
+              << "  snapshot <path> <name>  - Read-only snapshot (see /.snapshots)\n"
+              << "  snapshots               - List snapshots\n"
+              << "  snapshot-rm <name>      - Delete snapshot\n"
+              << "  clone <src> <dst>       - Copy-on-write clone of file/directory\n"
+              << "  fsck                    - Check and repair all blocks\n"
+              << "  recover <block_id>      - Recover specific block\n"
+              << "  rebuild-replica <n> [MB/s] - Resync replica n from its peers\n"
+              << "  help                    - Show this help\n"
+              << "  exit                    - Exit shell\n" << std::endl;
+}
+
+// True if the command succeeded and its result should be printed.
+// Failures are printed the way the shell always has: "<what>: <reason>"
+static bool show(Status status, const std::string& what, bool verbose) {
+    if (!verbose) return false;
+    
+    if (status != Status::OK) {
+        std::cerr << what << ": " << statusMessage(status) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Parse a non-negative decimal number; false on anything else
+static bool parseNumber(const std::string& text, size_t& value) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    try {
+        value = std::stoul(text);
+    } catch (const std::exception&) {
+        return false; // Out of range
+    }
+    return true;
+}
+
+static std::string joinData(const std::vector<std::string>& tokens, size_t first) {
+    std::string data;
+    for (size_t i = first; i < tokens.size(); i++) {
+        data += tokens[i];
+        if (i < tokens.size() - 1) data += " ";
+    }
+    return data;
+}
+
+Status runCommand(FileSystem& fs, const std::vector<std::string>& tokens, bool verbose) {
+    if (tokens.empty()) return Status::INVALID_ARGUMENT;
+    
+    const std::string& cmd = tokens[0];
+    Status status = Status::OK;
+    
+    if (cmd == "format") {
+        status = fs.format();
+        if (show(status, "format", verbose)) {
+            std::cout << "Storage initialized at: " << fs.getStoragePath() << "\n"
+                      << "Replicas: " << fs.getNumReplicas() << "\n"
+                      << "Filesystem formatted successfully" << std::endl;
+        }
+    }
+    else if (cmd == "mkdir" && tokens.size() >= 2) {
+        status = fs.mkdir(tokens[1]);
+        if (show(status, tokens[1], verbose)) {
+            std::cout << "Directory created: " << tokens[1] << std::endl;
+        }
+    }
+    else if (cmd == "ls") {
+        std::string path = tokens.size() >= 2 ? tokens[1] : "/";
+        std::vector<std::string> entries;
+        
+        status = fs.ls(path, entries);
+        if (show(status, path, verbose)) {
+            if (entries.empty()) {
+                std::cout << "(empty)" << std::endl;
+            } else {
+                for (const auto& entry : entries) {
+                    std::cout << "  " << entry << std::endl;
+                }
+            }
+        }
+    }
+    else if (cmd == "write" && tokens.size() >= 3) {
+        std::string data = joinData(tokens, 2);
+        
+        status = fs.writeFile(tokens[1], data);
+        if (show(status, tokens[1], verbose)) {
+            size_t blocks = (data.size() + DATA_SIZE - 1) / DATA_SIZE;
+            std::cout << "File written: " << tokens[1] << " (" << data.size()
+                      << " bytes, " << blocks << " blocks)" << std::endl;
+        }
+    }
+    else if (cmd == "read" && tokens.size() >= 2) {
+        std::string data;
+        
+        status = fs.readFile(tokens[1], data);
+        if (show(status, tokens[1], verbose)) {
+            std::cout << "Content: " << data << std::endl;
+        }
+    }
+    else if (cmd == "rm" && tokens.size() >= 2) {
+        status = fs.deleteFile(tokens[1]);
+        if (show(status, tokens[1], verbose)) {
+            std::cout << "Deleted: " << tokens[1] << std::endl;
+        }
+    }
+    else if (cmd == "snapshot" && tokens.size() >= 3) {
+        status = fs.snapshot(tokens[1], tokens[2]);
+        if (show(status, tokens[2], verbose)) {
+            std::cout << "Snapshot created: " << tokens[2]
+                      << " (" << tokens[1] << ")" << std::endl;
+        }
+    }
+    else if (cmd == "snapshots") {
+        auto names = fs.listSnapshots();
+        
+        if (show(status, cmd, verbose)) {
+            if (names.empty()) {
+                std::cout << "(none)" << std::endl;
+            } else {
+                for (const auto& name : names) {
+                    std::cout << "  " << name << std::endl;
+                }
+            }
+        }
+    }
+    else if (cmd == "snapshot-rm" && tokens.size() >= 2) {
+        status = fs.deleteSnapshot(tokens[1]);
+        if (show(status, tokens[1], verbose)) {
+            std::cout << "Snapshot deleted: " << tokens[1] << std::endl;
+        }
+    }
+    else if (cmd == "clone" && tokens.size() >= 3) {
+        status = fs.clone(tokens[1], tokens[2]);
+        if (show(status, tokens[2], verbose)) {
+            std::cout << "Cloned: " << tokens[1] << " -> " << tokens[2] << std::endl;
+        }
+    }
+    else if (cmd == "fsck") {
+        RecoveryStats stats;
+        
+        status = fs.fsck(stats);
+        if (show(status, cmd, verbose) && stats.refs_repaired > 0) {
+            std::cout << "Reference counts repaired: " << stats.refs_repaired
+                      << " block(s)" << std::endl;
+        }
+    }
+    else if (cmd == "recover" && tokens.size() >= 2) {
+        size_t block_id;
+        if (!parseNumber(tokens[1], block_id)) {
+            status = Status::INVALID_ARGUMENT;
+            show(status, "block " + tokens[1], verbose);
+            return status;
+        }
+        
+        status = fs.recover(block_id);
+        show(status, "block " + tokens[1], verbose);
+    }
+    else if (cmd == "rebuild-replica" && tokens.size() >= 2) {
+        size_t replica;
+        size_t rate_mb = 0;
+        if (!parseNumber(tokens[1], replica) ||
+            (tokens.size() >= 3 && !parseNumber(tokens[2], rate_mb))) {
+            status = Status::INVALID_ARGUMENT;
+            show(status, "rebuild-replica", verbose);
+            return status;
+        }
+        
+        RebuildStats stats;
+        
+        status = fs.rebuildReplica(replica, stats, rate_mb * 1024 * 1024);
+        if (verbose && status != Status::INVALID_ARGUMENT) {
+            std::cout << "Rebuilt replica " << replica << ": " << stats.blocks_copied
+                      << " blocks copied, " << stats.blocks_failed << " failed in "
+                      << stats.seconds << "s" << std::endl;
+        }
+        show(status, "replica " + tokens[1], verbose);
+    }
+    else {
+        status = Status::INVALID_ARGUMENT;
+        if (verbose) {
+            std::cout << "Unknown command or invalid arguments. Type 'help' for usage." << std::endl;
+        }
+    }
+    
+    return status;
+}
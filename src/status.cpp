@@ -0,0 +1,16 @@
+#include "../include/status.h"
+
+const char* statusMessage(Status status) {
+    switch (status) {
+        case Status::OK:               return "OK";
+        case Status::NOT_FOUND:        return "No such file or directory";
+        case Status::ALREADY_EXISTS:   return "Already exists";
+        case Status::NOT_A_DIRECTORY:  return "Not a directory";
+        case Status::NOT_A_FILE:       return "Not a file";
+        case Status::INVALID_ARGUMENT: return "Invalid argument";
+        case Status::READ_ONLY:        return "Snapshots are read-only";
+        case Status::IO_ERROR:         return "I/O error";
+        case Status::UNRECOVERABLE:    return "Block corrupted on all replicas";
+    }
+    return "Unknown error";
+}
@@ -1,12 +1,16 @@
 #include "../include/storage.h"
 #include <fstream>
 #include <filesystem>
-#include <iostream>
 
 namespace fs = std::filesystem;
 
 BlockStorage::BlockStorage(const std::string& path, size_t replicas)
-    : base_path(path), num_replicas(replicas) {}
+    : base_path(path), num_replicas(replicas), trees(replicas), tree_files(replicas),
+      tree_loaded(replicas, false) {
+    for (size_t i = 0; i < num_replicas; i++) {
+        reloadTree(i);
+    }
+}
 
 std::string BlockStorage::getReplicaPath(size_t replica) const {
     return base_path + "/replica_" + std::to_string(replica);
@@ -16,6 +20,90 @@ std::string BlockStorage::getBlockPath(size_t replica, size_t block_id) const {
     return getReplicaPath(replica) + "/block_" + std::to_string(block_id) + ".blk";
 }
 
+std::string BlockStorage::getTreePath(size_t replica) const {
+    return getReplicaPath(replica) + "/merkle.idx";
+}
+
+std::fstream& BlockStorage::openTreeFile(size_t replica) {
+    std::fstream& file = tree_files[replica];
+    if (!file.is_open()) {
+        std::string path = getTreePath(replica);
+        file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!file.is_open()) {
+            // First leaf for this replica: create the index
+            std::ofstream(path, std::ios::binary);
+            file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+        }
+    }
+    return file;
+}
+
+bool BlockStorage::reloadTree(size_t replica) {
+    // Drop the open handle: the index may have been lost or replaced
+    tree_files[replica].close();
+    
+    if (trees[replica].load(getTreePath(replica))) {
+        tree_loaded[replica] = true;
+        return true;
+    }
+    
+    // Without its directory a replica has no known contents at all
+    if (!fs::exists(getReplicaPath(replica))) {
+        tree_loaded[replica] = false;
+        return false;
+    }
+    
+    // No index (storage predating indexes, or a replaced disk): derive it
+    // from the block files actually present
+    scanTree(replica);
+    tree_loaded[replica] = true;
+    return true;
+}
+
+void BlockStorage::scanTree(size_t replica) {
+    Block block;
+    for (size_t block_id : getBlockIds(replica)) {
+        if (readBlock(block_id, replica, block)) {
+            trees[replica].setLeaf(block_id, leafHash(block));
+        }
+    }
+    saveTree(replica);
+}
+
+bool BlockStorage::saveTree(size_t replica) {
+    tree_files[replica].close();
+    return trees[replica].save(getTreePath(replica));
+}
+
+void BlockStorage::flushTrees() {
+    for (auto& file : tree_files) {
+        if (file.is_open()) file.flush();
+    }
+}
+
+void BlockStorage::updateLeaf(size_t replica, size_t block_id, uint32_t hash, bool persist) {
+    trees[replica].setLeaf(block_id, hash);
+    if (persist) {
+        trees[replica].persistLeaf(openTreeFile(replica), block_id);
+    }
+}
+
+bool BlockStorage::writeReplica(size_t replica, size_t block_id, const Block& block,
+                                bool persist) {
+    std::string path = getBlockPath(replica, block_id);
+    
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    
+    file.write(reinterpret_cast<const char*>(&block), sizeof(Block));
+    file.close();
+    
+    updateLeaf(replica, block_id, leafHash(block), persist);
+    return true;
+}
+
 bool BlockStorage::initialize() {
     try {
         // Create base directory
@@ -24,13 +112,13 @@ bool BlockStorage::initialize() {
         // Create replica directories
         for (size_t i = 0; i < num_replicas; i++) {
             fs::create_directories(getReplicaPath(i));
+            if (!tree_loaded[i]) {
+                reloadTree(i);
+            }
         }
         
-        std::cout << "Storage initialized at: " << base_path << std::endl;
-        std::cout << "Replicas: " << num_replicas << std::endl;
         return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to initialize storage: " << e.what() << std::endl;
+    } catch (const std::exception&) {
         return false;
     }
 }
@@ -38,17 +126,9 @@ bool BlockStorage::initialize() {
 bool BlockStorage::writeBlock(size_t block_id, const Block& block) {
     // Write to all replicas
     for (size_t replica = 0; replica < num_replicas; replica++) {
-        std::string path = getBlockPath(replica, block_id);
-        
-        std::ofstream file(path, std::ios::binary);
-        if (!file) {
-            std::cerr << "Failed to write block " << block_id 
-                      << " to replica " << replica << std::endl;
+        if (!writeReplica(replica, block_id, block)) {
             return false;
         }
-        
-        file.write(reinterpret_cast<const char*>(&block), sizeof(Block));
-        file.close();
     }
     
     return true;
@@ -70,13 +150,45 @@ bool BlockStorage::blockExists(size_t block_id, size_t replica) const {
     return fs::exists(getBlockPath(replica, block_id));
 }
 
+bool BlockStorage::deleteBlock(size_t block_id) {
+    bool removed = true;
+    for (size_t replica = 0; replica < num_replicas; replica++) {
+        std::error_code ec;
+        fs::remove(getBlockPath(replica, block_id), ec);
+        if (ec) removed = false;
+        updateLeaf(replica, block_id, EMPTY_LEAF);
+    }
+    return removed;
+}
+
+bool BlockStorage::corruptBlock(size_t block_id, size_t replica) {
+    // Overwrite the start of the block without touching its hash tree leaf,
+    // like bit rot that only a checksum verification would notice
+    std::fstream file(getBlockPath(replica, block_id),
+                      std::ios::binary | std::ios::in | std::ios::out);
+    if (!file) {
+        return false;
+    }
+    
+    char garbage[100];
+    for (size_t i = 0; i < sizeof(garbage); i++) {
+        garbage[i] = static_cast<char>(0xA5 ^ (block_id + i * 31));
+    }
+    file.write(garbage, sizeof(garbage));
+    return file.good();
+}
+
 std::vector<size_t> BlockStorage::getAllBlockIds() const {
+    // Scan first replica
+    return getBlockIds(0);
+}
+
+std::vector<size_t> BlockStorage::getBlockIds(size_t replica) const {
     std::vector<size_t> block_ids;
     
-    // Scan first replica
-    if (!fs::exists(getReplicaPath(0))) return block_ids;
+    if (!fs::exists(getReplicaPath(replica))) return block_ids;
     
-    for (const auto& entry : fs::directory_iterator(getReplicaPath(0))) {
+    for (const auto& entry : fs::directory_iterator(getReplicaPath(replica))) {
         std::string filename = entry.path().filename().string();
         if (filename.find("block_") == 0 && filename.find(".blk") != std::string::npos) {
             size_t id = std::stoul(filename.substr(6));
@@ -0,0 +1,70 @@
+#!/bin/bash
+
+TRACES=./data/batch_traces
+FAILED=0
+
+check() {
+    if eval "$2"; then
+        echo "PASS: $1"
+    else
+        echo "FAIL: $1"
+        FAILED=1
+    fi
+}
+
+# "<ops> <errors>" from a command's row of the report
+row() {
+    awk -v cmd="$1" '$1 == cmd { print $2, $3 }'
+}
+
+rm -rf "$TRACES"
+mkdir -p "$TRACES"
+
+echo "1. Report counts..."
+cat > "$TRACES/script.txt" << 'EOF'
+# One mkdir per session: it only succeeds if $SESSION expands
+mkdir /s$SESSION
+write /s$SESSION/a hello
+read /s$SESSION/a
+read /s$SESSION/missing
+EOF
+OUT=$(./build/shfs --batch "$TRACES/script.txt" --format --sessions 3 --iterations 2)
+echo "$OUT" | head -2
+check "total op count" "echo \"\$OUT\" | grep -q '^Total: 24 ops'"
+check "mkdir fails only on the repeat iteration" "[ \"\$(echo \"\$OUT\" | row mkdir)\" = '6 3' ]"
+check "write counts" "[ \"\$(echo \"\$OUT\" | row write)\" = '6 0' ]"
+check "read errors counted" "[ \"\$(echo \"\$OUT\" | row read)\" = '12 6' ]"
+
+echo -e "\n2. Exit status..."
+./build/shfs --help > /dev/null
+check "--help exits 0" "[ $? -eq 0 ]"
+./build/shfs --batch "$TRACES/script.txt" --sessions abc > /dev/null
+check "non-numeric option exits 1" "[ $? -eq 1 ]"
+./build/shfs --batch "$TRACES/none.txt" 2> /dev/null
+check "missing script exits 1" "[ $? -eq 1 ]"
+printf 'write /a x\n@abc read /a\n' > "$TRACES/bad.txt"
+ERR=$(./build/shfs --batch "$TRACES/bad.txt" 2>&1)
+check "malformed offset exits 1" "[ $? -eq 1 ]"
+check "error names the line" "echo \"\$ERR\" | grep -q 'line 2'"
+printf '@-5 write /a x\n' > "$TRACES/negative.txt"
+./build/shfs --batch "$TRACES/negative.txt" 2> /dev/null
+check "negative offset exits 1" "[ $? -eq 1 ]"
+
+echo -e "\n3. Record, then replay..."
+./build/shfs --record "$TRACES/recorded.txt" > /dev/null 2>&1 << EOF
+format
+write /r.txt recorded
+read /r.txt
+read /nowhere
+help
+exit
+EOF
+check "commands recorded with offsets" \
+    "[ \$(grep -c '^@[0-9]* ' $TRACES/recorded.txt) -eq 4 ]"
+OUT=$(./build/shfs --batch "$TRACES/recorded.txt")
+check "replay runs every recorded op" "echo \"\$OUT\" | grep -q '^Total: 4 ops'"
+check "replayed read errors" "[ \"\$(echo \"\$OUT\" | row read)\" = '2 1' ]"
+
+rm -rf "$TRACES"
+
+exit $FAILED
@@ -0,0 +1,118 @@
+#!/bin/bash
+
+STORAGE=./data/fs_storage
+SAVED=./data/saved_replica
+FAILED=0
+
+check() {
+    if eval "$2"; then
+        echo "PASS: $1"
+    else
+        echo "FAIL: $1"
+        FAILED=1
+    fi
+}
+
+# Index leaves as hex words, without trailing empty leaves: save() pads
+# to a power of two while incremental updates stop at the highest id
+leaves() {
+    od -An -v -tx4 "$1" | tr -s ' ' '\n' |
+        awk 'NF { a[n++] = $1; if ($1 != "00000000") last = n }
+             END { for (i = 0; i < last; i++) print a[i] }'
+}
+
+rm -rf "$STORAGE" "$SAVED"
+
+echo "1. Lost replica..."
+./build/shfs > /dev/null << EOF
+format
+write /a.txt First file
+write /b.txt Second file
+write /c.txt Third file
+write /d.txt Fourth file
+write /e.txt Fifth file
+exit
+EOF
+rm -rf "$STORAGE/replica_1"
+./build/shfs << EOF | grep Rebuilt
+rebuild-replica 1
+exit
+EOF
+check "replica_1 blocks restored" \
+    "for b in 0 1 2 3 4; do cmp -s $STORAGE/replica_0/block_\$b.blk $STORAGE/replica_1/block_\$b.blk || exit 1; done"
+check "replica_1 index restored" \
+    "[ \"\$(leaves $STORAGE/replica_0/merkle.idx)\" = \"\$(leaves $STORAGE/replica_1/merkle.idx)\" ]"
+
+echo -e "\n2. Stale replica (same block id, different data)..."
+rm -rf "$STORAGE"
+./build/shfs > /dev/null << EOF
+format
+write /a.txt OLDCONTENT
+exit
+EOF
+cp -r "$STORAGE/replica_2" "$SAVED"
+./build/shfs > /dev/null << EOF
+format
+write /a.txt NEWCONTENT-different
+exit
+EOF
+rm -rf "$STORAGE/replica_2" && mv "$SAVED" "$STORAGE/replica_2"
+./build/shfs << EOF | grep Rebuilt
+rebuild-replica 2
+exit
+EOF
+check "stale block replaced" "cmp -s $STORAGE/replica_0/block_0.blk $STORAGE/replica_2/block_0.blk"
+
+echo -e "\n3. Stale extra block..."
+rm -rf "$STORAGE"
+./build/shfs > /dev/null << EOF
+format
+write /a.txt Kept
+write /b.txt Deleted later
+exit
+EOF
+cp -r "$STORAGE/replica_2" "$SAVED"
+./build/shfs > /dev/null << EOF
+format
+write /a.txt Kept
+write /b.txt Deleted later
+rm /b.txt
+exit
+EOF
+rm -rf "$STORAGE/replica_2" && mv "$SAVED" "$STORAGE/replica_2"
+check "extra block present before rebuild" "[ -f $STORAGE/replica_2/block_1.blk ]"
+./build/shfs << EOF | grep Rebuilt
+rebuild-replica 2
+exit
+EOF
+check "extra block removed" "[ ! -f $STORAGE/replica_2/block_1.blk ]"
+check "kept block intact" "cmp -s $STORAGE/replica_0/block_0.blk $STORAGE/replica_2/block_0.blk"
+
+echo -e "\n4. Storage without any index..."
+rm -rf "$STORAGE"
+./build/shfs > /dev/null << EOF
+format
+write /a.txt First file
+write /b.txt Second file
+exit
+EOF
+rm -f "$STORAGE"/replica_*/merkle.idx "$STORAGE"/replica_1/block_*.blk
+./build/shfs << EOF | grep Rebuilt
+rebuild-replica 1
+exit
+EOF
+check "indexes derived from block files" \
+    "cmp -s $STORAGE/replica_0/block_1.blk $STORAGE/replica_1/block_1.blk"
+
+echo -e "\n5. Missing peers..."
+mv "$STORAGE/replica_0" "$SAVED"
+rm -rf "$STORAGE/replica_2"
+./build/shfs > /dev/null 2>&1 << EOF
+rebuild-replica 1
+exit
+EOF
+check "no blocks removed while peers are missing" \
+    "[ -f $STORAGE/replica_1/block_0.blk ] && [ -f $STORAGE/replica_1/block_1.blk ]"
+rm -rf "$SAVED"
+
+exit $FAILED
@@ -0,0 +1,90 @@
+#!/bin/bash
+
+STORAGE=./data/fs_storage
+FAILED=0
+
+check() {
+    if eval "$2"; then
+        echo "PASS: $1"
+    else
+        echo "FAIL: $1"
+        FAILED=1
+    fi
+}
+
+# Content lines of a session, joined with '|'
+contents() {
+    grep -o "Content: .*" | sed 's/Content: //' | paste -sd'|' -
+}
+
+rm -rf "$STORAGE"
+
+echo "1. Snapshot survives overwrite and rm of the live file..."
+OUT=$(./build/shfs 2>&1 << EOF
+format
+mkdir /d
+write /d/a ORIGINAL
+snapshot /d s1
+write /d/a OVERWRITTEN
+read /d/a
+read /.snapshots/s1/a
+rm /d/a
+read /.snapshots/s1/a
+write /.snapshots/s1/a NOPE
+fsck
+exit
+EOF
+)
+check "snapshot keeps original data" "[ \"\$(echo \"\$OUT\" | contents)\" = 'OVERWRITTEN|ORIGINAL|ORIGINAL' ]"
+check "snapshot is read-only" "echo \"\$OUT\" | grep -q 'read-only'"
+check "shared block kept" "[ -f $STORAGE/replica_0/block_0.blk ]"
+check "unshared block freed by rm" "[ ! -f $STORAGE/replica_0/block_1.blk ]"
+check "fsck finds consistent refcounts" "! echo \"\$OUT\" | grep -q 'Reference counts repaired'"
+
+echo -e "\n2. snapshot-rm frees blocks only when unused..."
+rm -rf "$STORAGE"
+# 'recover <id>' only complains when no replica holds the block
+OUT=$(./build/shfs 2>&1 << EOF
+format
+mkdir /d
+write /d/a SHARED
+snapshot /d s1
+snapshot /d s2
+snapshot-rm s1
+recover 0
+rm /d/a
+recover 0
+snapshot-rm s2
+recover 0
+fsck
+exit
+EOF
+)
+check "block kept while live file and s2 use it" \
+    "[ \$(echo \"\$OUT\" | grep -c 'block 0:') -eq 1 ]"
+check "block freed with the last snapshot" "[ ! -f $STORAGE/replica_0/block_0.blk ]"
+check "fsck finds consistent refcounts" "! echo \"\$OUT\" | grep -q 'Reference counts repaired'"
+
+echo -e "\n3. Clone, then write on either side..."
+rm -rf "$STORAGE"
+OUT=$(./build/shfs 2>&1 << EOF
+format
+mkdir /src
+write /src/f ORIG
+clone /src /dst
+write /dst/f DSTNEW
+read /src/f
+read /dst/f
+write /src/f SRCNEW
+read /src/f
+read /dst/f
+fsck
+exit
+EOF
+)
+check "writes stay on their own side" "[ \"\$(echo \"\$OUT\" | contents)\" = 'ORIG|DSTNEW|SRCNEW|DSTNEW' ]"
+check "original block freed once both sides moved on" "[ ! -f $STORAGE/replica_0/block_0.blk ]"
+check "both new blocks kept" "[ -f $STORAGE/replica_0/block_1.blk ] && [ -f $STORAGE/replica_0/block_2.blk ]"
+check "fsck finds consistent refcounts" "! echo \"\$OUT\" | grep -q 'Reference counts repaired'"
+
+exit $FAILED